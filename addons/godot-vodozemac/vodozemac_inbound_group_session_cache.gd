@@ -0,0 +1,264 @@
+class_name VodozemacInboundGroupSessionCache
+extends RefCounted
+## Bounded cache of inbound group sessions keyed by (room_id, session_id).
+##
+## Sessions are kept as pickles and only unpickled with
+## VodozemacInboundGroupSession.from_pickle() when first used. At most
+## `max_resident` sessions stay unpickled; when that limit is exceeded the least
+## recently used one is pickled back and released, which frees its native state.
+## Pickles live in memory, or in one file per session under `storage_dir` when
+## one is given, so resident memory and startup cost do not grow with the size
+## of the key store.
+##
+## Files under `storage_dir` are named by a hash of (room_id, session_id), so
+## the directory cannot be listed back into a cache. To reopen it, keep your own
+## record of the ids and register each session with add_stored().
+##
+## Errors follow the Vodozemac* classes: methods return an Error or a result
+## Dictionary with "success"/"error", and get_last_error() holds the last message.
+
+const PICKLE_EXTENSION := ".pickle"
+const PICKLE_KEY_SIZE := 32
+
+## Largest number of unpickled sessions; lowering it evicts immediately.
+var max_resident := 1024:
+	set(value):
+		max_resident = maxi(value, 1)
+		_evict()
+
+var _pickle_key: PackedByteArray
+var _storage_dir := ""
+## cache key -> pickle for every session that is not resident. In storage_dir
+## mode the value is "" and the pickle is in the session's file.
+var _pickles := {}
+## cache key -> VodozemacInboundGroupSession, least recently used first.
+var _resident := {}
+var _last_error := ""
+
+
+func _init(pickle_key: PackedByteArray, resident_limit := 1024, storage_dir := "") -> void:
+	_pickle_key = pickle_key
+	if not _has_valid_key():
+		push_error(_last_error)
+	_storage_dir = ProjectSettings.globalize_path(storage_dir) if not storage_dir.is_empty() else ""
+	max_resident = resident_limit
+
+
+## Adds a live session, replacing any session cached under the same key.
+func add_session(room_id: String, session: VodozemacInboundGroupSession) -> Error:
+	if not _has_valid_key():
+		return ERR_INVALID_PARAMETER
+	var cache_key := _cache_key(room_id, session.get_session_id())
+	_pickles.erase(cache_key)
+	_touch(cache_key, session)
+	return _evict()
+
+
+## Adds a pickled session without unpickling it.
+func add_pickle(room_id: String, session_id: String, pickle: String) -> Error:
+	if not _has_valid_key():
+		return ERR_INVALID_PARAMETER
+	if pickle.is_empty():
+		_last_error = "Empty pickle for inbound group session %s in %s" % [session_id, room_id]
+		return ERR_INVALID_PARAMETER
+	var cache_key := _cache_key(room_id, session_id)
+	_resident.erase(cache_key)
+	return _store(cache_key, pickle)
+
+
+## Registers a session whose pickle is already in `storage_dir`, for example one
+## written by flush() before a restart. The file is neither read nor rewritten.
+func add_stored(room_id: String, session_id: String) -> Error:
+	if not _has_valid_key():
+		return ERR_INVALID_PARAMETER
+	if _storage_dir.is_empty():
+		_last_error = "add_stored() needs a storage_dir"
+		return ERR_UNCONFIGURED
+	var cache_key := _cache_key(room_id, session_id)
+	if not FileAccess.file_exists(_file_path(cache_key)):
+		_last_error = "No stored pickle for inbound group session %s in %s" % [session_id, room_id]
+		return ERR_FILE_NOT_FOUND
+	_resident.erase(cache_key)
+	_pickles[cache_key] = ""
+	return OK
+
+
+func has_session(room_id: String, session_id: String) -> bool:
+	var cache_key := _cache_key(room_id, session_id)
+	return _resident.has(cache_key) or _pickles.has(cache_key)
+
+
+## True when the session is currently unpickled.
+func is_resident(room_id: String, session_id: String) -> bool:
+	return _resident.has(_cache_key(room_id, session_id))
+
+
+## Returns the session, unpickling it if needed, or null with get_last_error() set.
+func get_session(room_id: String, session_id: String) -> VodozemacInboundGroupSession:
+	var cache_key := _cache_key(room_id, session_id)
+	var session: VodozemacInboundGroupSession = _resident.get(cache_key)
+	if session != null:
+		_touch(cache_key, session)
+		return session
+	if not _has_valid_key():
+		return null
+	if not _pickles.has(cache_key):
+		_last_error = "Unknown inbound group session %s in %s" % [session_id, room_id]
+		return null
+
+	var pickle := _load(cache_key)
+	if pickle.is_empty():
+		return null
+	session = VodozemacInboundGroupSession.new()
+	if session.from_pickle(pickle, _pickle_key) != OK:
+		_last_error = session.get_last_error()
+		return null
+	_pickles.erase(cache_key)
+	_touch(cache_key, session)
+	if _evict() != OK:
+		return null
+	return session
+
+
+## Same result shape as VodozemacInboundGroupSession.decrypt().
+func decrypt(room_id: String, session_id: String, ciphertext: String) -> Dictionary:
+	var session := get_session(room_id, session_id)
+	if session == null:
+		return {"success": false, "error": _last_error}
+	return session.decrypt(ciphertext)
+
+
+## Current pickle of a session, taken from the live session when it is resident.
+## Returns "" with get_last_error() set on failure.
+func get_pickle(room_id: String, session_id: String) -> String:
+	if not _has_valid_key():
+		return ""
+	var cache_key := _cache_key(room_id, session_id)
+	if _resident.has(cache_key):
+		var session: VodozemacInboundGroupSession = _resident[cache_key]
+		var pickle := session.pickle(_pickle_key)
+		if pickle.is_empty():
+			_last_error = session.get_last_error()
+		return pickle
+	if not _pickles.has(cache_key):
+		_last_error = "Unknown inbound group session %s in %s" % [session_id, room_id]
+		return ""
+	return _load(cache_key)
+
+
+func remove_session(room_id: String, session_id: String) -> void:
+	var cache_key := _cache_key(room_id, session_id)
+	_resident.erase(cache_key)
+	_pickles.erase(cache_key)
+	if not _storage_dir.is_empty() and FileAccess.file_exists(_file_path(cache_key)):
+		DirAccess.remove_absolute(_file_path(cache_key))
+
+
+## In storage_dir mode, writes the files of resident sessions so the directory
+## holds a current pickle of every cached session; sessions stay resident. A new
+## cache on the same directory can then pick them up with add_stored().
+## In memory mode there are no files and this returns ERR_UNCONFIGURED; save
+## get_pickle() results instead.
+func flush() -> Error:
+	if _storage_dir.is_empty():
+		_last_error = "flush() needs a storage_dir"
+		return ERR_UNCONFIGURED
+	if not _has_valid_key():
+		return ERR_INVALID_PARAMETER
+	for cache_key in _resident:
+		var pickle: String = _resident[cache_key].pickle(_pickle_key)
+		if pickle.is_empty():
+			_last_error = _resident[cache_key].get_last_error()
+			return FAILED
+		if _write(cache_key, pickle) != OK:
+			return FAILED
+	return OK
+
+
+func get_session_count() -> int:
+	return _pickles.size() + _resident.size()
+
+
+func get_resident_count() -> int:
+	return _resident.size()
+
+
+func get_last_error() -> String:
+	return _last_error
+
+
+func _has_valid_key() -> bool:
+	if _pickle_key.size() == PICKLE_KEY_SIZE:
+		return true
+	_last_error = "Pickle key must be %d bytes, got %d" % [PICKLE_KEY_SIZE, _pickle_key.size()]
+	return false
+
+
+## Room ids and base64 session ids never contain a newline.
+func _cache_key(room_id: String, session_id: String) -> String:
+	return room_id + "\n" + session_id
+
+
+## Moves `cache_key` to the most recently used end.
+func _touch(cache_key: String, session: VodozemacInboundGroupSession) -> void:
+	_resident.erase(cache_key)
+	_resident[cache_key] = session
+
+
+func _evict() -> Error:
+	while _resident.size() > max_resident:
+		var oldest: String
+		for cache_key in _resident:
+			oldest = cache_key
+			break
+		var session: VodozemacInboundGroupSession = _resident[oldest]
+		var pickle := session.pickle(_pickle_key)
+		if pickle.is_empty():
+			_last_error = session.get_last_error()
+			return FAILED
+		_resident.erase(oldest)
+		if _store(oldest, pickle) != OK:
+			return FAILED
+	return OK
+
+
+func _store(cache_key: String, pickle: String) -> Error:
+	if _storage_dir.is_empty():
+		_pickles[cache_key] = pickle
+		return OK
+	if _write(cache_key, pickle) != OK:
+		return FAILED
+	_pickles[cache_key] = ""
+	return OK
+
+
+func _load(cache_key: String) -> String:
+	if _storage_dir.is_empty():
+		return _pickles[cache_key]
+	var path := _file_path(cache_key)
+	var file := FileAccess.open(path, FileAccess.READ)
+	if file == null:
+		_last_error = "Cannot read %s: %s" % [path, error_string(FileAccess.get_open_error())]
+		return ""
+	var pickle := file.get_as_text()
+	if pickle.is_empty():
+		_last_error = "Stored pickle %s is empty" % path
+	return pickle
+
+
+func _write(cache_key: String, pickle: String) -> Error:
+	var error := DirAccess.make_dir_recursive_absolute(_storage_dir)
+	if error != OK:
+		_last_error = "Cannot create %s: %s" % [_storage_dir, error_string(error)]
+		return error
+	var path := _file_path(cache_key)
+	var file := FileAccess.open(path, FileAccess.WRITE)
+	if file == null:
+		_last_error = "Cannot write %s: %s" % [path, error_string(FileAccess.get_open_error())]
+		return FileAccess.get_open_error()
+	file.store_string(pickle)
+	return OK
+
+
+func _file_path(cache_key: String) -> String:
+	return _storage_dir.path_join(cache_key.sha256_text() + PICKLE_EXTENSION)
@@ -0,0 +1,401 @@
+extends RefCounted
+## Benchmark cases covering every bound method of the four Vodozemac* classes.
+##
+## Each case is a Dictionary with:
+##   name     - "<Class>.<method>" plus "/<bytes>" for payload-sized cases
+##   class    - registered class name
+##   method   - bound method under test
+##   payload  - plaintext size in bytes, or -1 when not applicable
+##   setup    - Callable(calls: int) -> Dictionary, builds the state for `calls` invocations
+##   invoke   - Callable(state: Dictionary, index: int) -> bool, one timed invocation
+
+const PICKLE_KEY_SIZE := 32
+
+
+func build(payload_sizes: PackedInt32Array) -> Array:
+	var cases: Array = []
+
+	var account := "VodozemacAccount"
+	cases.append(_case(account, "get_last_error", _with_account, _account_get_last_error))
+	cases.append(_case(account, "initialize", _with_nothing, _account_initialize))
+	cases.append(_case(account, "get_identity_keys", _with_account, _account_get_identity_keys))
+	cases.append(_case(account, "generate_one_time_keys", _with_account, _account_generate_one_time_keys))
+	cases.append(_case(account, "get_one_time_keys", _with_full_key_pool, _account_get_one_time_keys))
+	cases.append(_case(account, "mark_keys_as_published", _with_unpublished_keys, _account_mark_keys_as_published))
+	cases.append(_case(account, "get_max_number_of_one_time_keys", _with_account, _account_get_max_number_of_one_time_keys))
+	cases.append(_case(account, "create_outbound_session", _with_remote_one_time_key, _account_create_outbound_session))
+	cases.append(_case(account, "create_inbound_session", _with_pre_key_messages, _account_create_inbound_session))
+	cases.append(_case(account, "pickle", _with_account, _account_pickle))
+	cases.append(_case(account, "from_pickle", _with_account_pickle, _account_from_pickle))
+
+	var session := "VodozemacSession"
+	cases.append(_case(session, "get_last_error", _with_olm_pair, _session_get_last_error))
+	cases.append(_case(session, "get_session_id", _with_olm_pair, _session_get_session_id))
+	cases.append(_case(session, "session_matches", _with_olm_pair, _session_session_matches))
+	for size in payload_sizes:
+		var plaintext := "a".repeat(size)
+		cases.append(_case(session, "encrypt", _with_olm_pair, _session_encrypt.bind(plaintext), size))
+		cases.append(_case(session, "decrypt", _with_olm_messages.bind(plaintext), _session_decrypt, size))
+	cases.append(_case(session, "pickle", _with_olm_pair, _session_pickle))
+	cases.append(_case(session, "from_pickle", _with_session_pickle, _session_from_pickle))
+
+	var group := "VodozemacGroupSession"
+	cases.append(_case(group, "get_last_error", _with_megolm_pair, _group_get_last_error))
+	cases.append(_case(group, "initialize", _with_nothing, _group_initialize))
+	cases.append(_case(group, "get_session_id", _with_megolm_pair, _group_get_session_id))
+	cases.append(_case(group, "get_session_key", _with_megolm_pair, _group_get_session_key))
+	cases.append(_case(group, "get_message_index", _with_megolm_pair, _group_get_message_index))
+	for size in payload_sizes:
+		cases.append(_case(group, "encrypt", _with_megolm_pair, _group_encrypt.bind("a".repeat(size)), size))
+	cases.append(_case(group, "pickle", _with_megolm_pair, _group_pickle))
+	cases.append(_case(group, "from_pickle", _with_group_pickle, _group_from_pickle))
+
+	var inbound := "VodozemacInboundGroupSession"
+	cases.append(_case(inbound, "get_last_error", _with_megolm_pair, _inbound_get_last_error))
+	cases.append(_case(inbound, "initialize_from_session_key", _with_session_key, _inbound_initialize_from_session_key))
+	cases.append(_case(inbound, "import_session", _with_exported_key, _inbound_import_session))
+	cases.append(_case(inbound, "get_session_id", _with_megolm_pair, _inbound_get_session_id))
+	cases.append(_case(inbound, "get_first_known_index", _with_megolm_pair, _inbound_get_first_known_index))
+	cases.append(_case(inbound, "export_at_index", _with_megolm_pair, _inbound_export_at_index))
+	for size in payload_sizes:
+		cases.append(_case(inbound, "decrypt", _with_megolm_messages.bind("a".repeat(size)), _inbound_decrypt, size))
+	cases.append(_case(inbound, "pickle", _with_megolm_pair, _inbound_pickle))
+	cases.append(_case(inbound, "from_pickle", _with_inbound_pickle, _inbound_from_pickle))
+
+	return cases
+
+
+func pickle_key() -> PackedByteArray:
+	var key := PackedByteArray()
+	key.resize(PICKLE_KEY_SIZE)
+	for i in PICKLE_KEY_SIZE:
+		key[i] = i
+	return key
+
+
+func new_account() -> VodozemacAccount:
+	var account := VodozemacAccount.new()
+	if account.initialize() != OK:
+		push_error("VodozemacAccount.initialize failed: %s" % account.get_last_error())
+	return account
+
+
+func identity_key(account: VodozemacAccount) -> String:
+	return account.get_identity_keys()["curve25519"]
+
+
+## Unpublished one-time keys of `account`; get_one_time_keys() maps key id to base64 key.
+func one_time_keys(account: VodozemacAccount) -> Array:
+	return account.get_one_time_keys().values()
+
+
+## Alice -> Bob Olm channel where Bob has already accepted the first pre-key message.
+func olm_pair() -> Dictionary:
+	var alice := new_account()
+	var bob := new_account()
+	bob.generate_one_time_keys(1)
+	var otk: String = one_time_keys(bob)[0]
+	bob.mark_keys_as_published()
+
+	var outbound: VodozemacSession = alice.create_outbound_session(identity_key(bob), otk)
+	var first: Dictionary = outbound.encrypt("hello")
+	var accepted: Dictionary = bob.create_inbound_session(identity_key(alice), first["message_type"], first["ciphertext"])
+	if not accepted.get("success", false):
+		push_error("create_inbound_session failed: %s" % accepted.get("error", ""))
+	return {
+		"alice": alice,
+		"bob": bob,
+		"outbound": outbound,
+		"inbound": accepted.get("session"),
+		"first": first,
+	}
+
+
+## Outbound group session plus an inbound copy initialized from its session key.
+func megolm_pair() -> Dictionary:
+	var group := VodozemacGroupSession.new()
+	if group.initialize() != OK:
+		push_error("VodozemacGroupSession.initialize failed: %s" % group.get_last_error())
+	var inbound := VodozemacInboundGroupSession.new()
+	if inbound.initialize_from_session_key(group.get_session_key()) != OK:
+		push_error("VodozemacInboundGroupSession.initialize_from_session_key failed: %s" % inbound.get_last_error())
+	return {"group": group, "inbound": inbound}
+
+
+func _case(cls: String, method: String, setup: Callable, invoke: Callable, payload := -1) -> Dictionary:
+	var name := "%s.%s" % [cls, method]
+	if payload >= 0:
+		name += "/%d" % payload
+	return {
+		"name": name,
+		"class": cls,
+		"method": method,
+		"payload": payload,
+		"setup": setup,
+		"invoke": invoke,
+	}
+
+
+# Setup
+
+func _with_nothing(_calls: int) -> Dictionary:
+	return {}
+
+
+func _with_account(_calls: int) -> Dictionary:
+	return {"account": new_account(), "key": pickle_key()}
+
+
+func _with_full_key_pool(_calls: int) -> Dictionary:
+	var account := new_account()
+	account.generate_one_time_keys(account.get_max_number_of_one_time_keys())
+	return {"account": account}
+
+
+## One account per call, each holding one unpublished one-time key, so every
+## timed mark_keys_as_published() has a key to publish.
+func _with_unpublished_keys(calls: int) -> Dictionary:
+	var accounts: Array = []
+	for i in calls:
+		var account := new_account()
+		account.generate_one_time_keys(1)
+		accounts.append(account)
+	return {"accounts": accounts}
+
+
+func _with_remote_one_time_key(_calls: int) -> Dictionary:
+	var bob := new_account()
+	bob.generate_one_time_keys(1)
+	return {"alice": new_account(), "bob_key": identity_key(bob), "otk": one_time_keys(bob)[0]}
+
+
+## Every inbound session consumes a one-time key, so the pre-key messages are
+## spread over as many receiving accounts as the per-account key limit requires.
+func _with_pre_key_messages(calls: int) -> Dictionary:
+	var alice := new_account()
+	var entries: Array = []
+	while entries.size() < calls:
+		var bob := new_account()
+		bob.generate_one_time_keys(mini(bob.get_max_number_of_one_time_keys(), calls - entries.size()))
+		var bob_key := identity_key(bob)
+		for otk in one_time_keys(bob):
+			var outbound: VodozemacSession = alice.create_outbound_session(bob_key, otk)
+			entries.append({"bob": bob, "message": outbound.encrypt("hello")})
+		bob.mark_keys_as_published()
+	return {"alice_key": identity_key(alice), "entries": entries}
+
+
+func _with_account_pickle(_calls: int) -> Dictionary:
+	var key := pickle_key()
+	return {"pickle": new_account().pickle(key), "key": key}
+
+
+func _with_olm_pair(_calls: int) -> Dictionary:
+	var state := olm_pair()
+	state["key"] = pickle_key()
+	return state
+
+
+func _with_olm_messages(calls: int, plaintext: String) -> Dictionary:
+	var state := olm_pair()
+	var messages: Array = []
+	for i in calls:
+		messages.append(state["outbound"].encrypt(plaintext))
+	state["messages"] = messages
+	return state
+
+
+func _with_session_pickle(_calls: int) -> Dictionary:
+	var key := pickle_key()
+	return {"pickle": olm_pair()["inbound"].pickle(key), "key": key}
+
+
+func _with_megolm_pair(_calls: int) -> Dictionary:
+	var state := megolm_pair()
+	state["key"] = pickle_key()
+	return state
+
+
+func _with_megolm_messages(calls: int, plaintext: String) -> Dictionary:
+	var state := megolm_pair()
+	var messages := PackedStringArray()
+	for i in calls:
+		messages.append(state["group"].encrypt(plaintext).get("ciphertext", ""))
+	state["messages"] = messages
+	return state
+
+
+func _with_group_pickle(_calls: int) -> Dictionary:
+	var key := pickle_key()
+	return {"pickle": megolm_pair()["group"].pickle(key), "key": key}
+
+
+func _with_session_key(_calls: int) -> Dictionary:
+	return {"session_key": megolm_pair()["group"].get_session_key()}
+
+
+func _with_exported_key(_calls: int) -> Dictionary:
+	return {"exported": megolm_pair()["inbound"].export_at_index(0).get("exported_key", "")}
+
+
+func _with_inbound_pickle(_calls: int) -> Dictionary:
+	var key := pickle_key()
+	return {"pickle": megolm_pair()["inbound"].pickle(key), "key": key}
+
+
+# VodozemacAccount
+
+func _account_get_last_error(s: Dictionary, _i: int) -> bool:
+	s["account"].get_last_error()
+	return true
+
+
+func _account_initialize(_s: Dictionary, _i: int) -> bool:
+	return VodozemacAccount.new().initialize() == OK
+
+
+func _account_get_identity_keys(s: Dictionary, _i: int) -> bool:
+	return not s["account"].get_identity_keys().is_empty()
+
+
+func _account_generate_one_time_keys(s: Dictionary, _i: int) -> bool:
+	return s["account"].generate_one_time_keys(1) == OK
+
+
+func _account_get_one_time_keys(s: Dictionary, _i: int) -> bool:
+	return not s["account"].get_one_time_keys().is_empty()
+
+
+func _account_mark_keys_as_published(s: Dictionary, i: int) -> bool:
+	s["accounts"][i].mark_keys_as_published()
+	return true
+
+
+func _account_get_max_number_of_one_time_keys(s: Dictionary, _i: int) -> bool:
+	return s["account"].get_max_number_of_one_time_keys() > 0
+
+
+func _account_create_outbound_session(s: Dictionary, _i: int) -> bool:
+	return s["alice"].create_outbound_session(s["bob_key"], s["otk"]) != null
+
+
+func _account_create_inbound_session(s: Dictionary, i: int) -> bool:
+	var entry: Dictionary = s["entries"][i]
+	var message: Dictionary = entry["message"]
+	var result: Dictionary = entry["bob"].create_inbound_session(s["alice_key"], message["message_type"], message["ciphertext"])
+	return result.get("success", false)
+
+
+func _account_pickle(s: Dictionary, _i: int) -> bool:
+	return not s["account"].pickle(s["key"]).is_empty()
+
+
+func _account_from_pickle(s: Dictionary, _i: int) -> bool:
+	return VodozemacAccount.new().from_pickle(s["pickle"], s["key"]) == OK
+
+
+# VodozemacSession
+
+func _session_get_last_error(s: Dictionary, _i: int) -> bool:
+	s["outbound"].get_last_error()
+	return true
+
+
+func _session_get_session_id(s: Dictionary, _i: int) -> bool:
+	return not s["outbound"].get_session_id().is_empty()
+
+
+func _session_session_matches(s: Dictionary, _i: int) -> bool:
+	var first: Dictionary = s["first"]
+	return s["inbound"].session_matches(first["message_type"], first["ciphertext"])
+
+
+func _session_encrypt(s: Dictionary, _i: int, plaintext: String) -> bool:
+	return s["outbound"].encrypt(plaintext).get("success", false)
+
+
+func _session_decrypt(s: Dictionary, i: int) -> bool:
+	var message: Dictionary = s["messages"][i]
+	return s["inbound"].decrypt(message["message_type"], message["ciphertext"]).get("success", false)
+
+
+func _session_pickle(s: Dictionary, _i: int) -> bool:
+	return not s["inbound"].pickle(s["key"]).is_empty()
+
+
+func _session_from_pickle(s: Dictionary, _i: int) -> bool:
+	return VodozemacSession.new().from_pickle(s["pickle"], s["key"]) == OK
+
+
+# VodozemacGroupSession
+
+func _group_get_last_error(s: Dictionary, _i: int) -> bool:
+	s["group"].get_last_error()
+	return true
+
+
+func _group_initialize(_s: Dictionary, _i: int) -> bool:
+	return VodozemacGroupSession.new().initialize() == OK
+
+
+func _group_get_session_id(s: Dictionary, _i: int) -> bool:
+	return not s["group"].get_session_id().is_empty()
+
+
+func _group_get_session_key(s: Dictionary, _i: int) -> bool:
+	return not s["group"].get_session_key().is_empty()
+
+
+func _group_get_message_index(s: Dictionary, _i: int) -> bool:
+	return s["group"].get_message_index() >= 0
+
+
+func _group_encrypt(s: Dictionary, _i: int, plaintext: String) -> bool:
+	return s["group"].encrypt(plaintext).get("success", false)
+
+
+func _group_pickle(s: Dictionary, _i: int) -> bool:
+	return not s["group"].pickle(s["key"]).is_empty()
+
+
+func _group_from_pickle(s: Dictionary, _i: int) -> bool:
+	return VodozemacGroupSession.new().from_pickle(s["pickle"], s["key"]) == OK
+
+
+# VodozemacInboundGroupSession
+
+func _inbound_get_last_error(s: Dictionary, _i: int) -> bool:
+	s["inbound"].get_last_error()
+	return true
+
+
+func _inbound_initialize_from_session_key(s: Dictionary, _i: int) -> bool:
+	return VodozemacInboundGroupSession.new().initialize_from_session_key(s["session_key"]) == OK
+
+
+func _inbound_import_session(s: Dictionary, _i: int) -> bool:
+	return VodozemacInboundGroupSession.new().import_session(s["exported"]) == OK
+
+
+func _inbound_get_session_id(s: Dictionary, _i: int) -> bool:
+	return not s["inbound"].get_session_id().is_empty()
+
+
+func _inbound_get_first_known_index(s: Dictionary, _i: int) -> bool:
+	return s["inbound"].get_first_known_index() >= 0
+
+
+func _inbound_export_at_index(s: Dictionary, _i: int) -> bool:
+	return s["inbound"].export_at_index(0).get("success", false)
+
+
+func _inbound_decrypt(s: Dictionary, i: int) -> bool:
+	return s["inbound"].decrypt(s["messages"][i]).get("success", false)
+
+
+func _inbound_pickle(s: Dictionary, _i: int) -> bool:
+	return not s["inbound"].pickle(s["key"]).is_empty()
+
+
+func _inbound_from_pickle(s: Dictionary, _i: int) -> bool:
+	return VodozemacInboundGroupSession.new().from_pickle(s["pickle"], s["key"]) == OK
@@ -0,0 +1,85 @@
+extends RefCounted
+## Compares benchmark results against a previously saved report.
+##
+## A metric regresses when it is worse than the baseline by more than the
+## threshold percentage and by more than the metric's absolute slack; the slack
+## keeps microsecond rounding and allocator noise on cheap calls from failing a run.
+
+## metric name -> [higher_is_better, absolute slack]
+const METRICS := {
+	"ops_per_sec": [true, 0.0],
+	"p99_usec": [false, 2.0],
+	"retained_memory_bytes": [false, 4096.0],
+}
+
+
+## Loads a report written by bench_runner.gd; returns an empty Dictionary on failure.
+func load_report(path: String) -> Dictionary:
+	var file := FileAccess.open(ProjectSettings.globalize_path(path), FileAccess.READ)
+	if file == null:
+		printerr("Cannot read baseline %s: %s" % [path, error_string(FileAccess.get_open_error())])
+		return {}
+	var text := file.get_as_text()
+	if text.is_empty():
+		printerr("Baseline %s is empty" % path)
+		return {}
+	var report = JSON.parse_string(text)
+	if not (report is Dictionary) or not report.has("results"):
+		printerr("Baseline %s is not a benchmark report" % path)
+		return {}
+	return report
+
+
+## Returns one entry per compared metric:
+## {name, metric, baseline, current, change_percent, regressed}.
+## Cases present in only one of the two runs are printed and skipped, and so are
+## metrics present for only one side of a case (retained_memory_bytes is missing
+## from release-build reports).
+func compare(baseline: Dictionary, results: Array, threshold_percent: float) -> Array:
+	var previous := {}
+	for result in baseline["results"]:
+		previous[result["name"]] = result
+	var current := {}
+	for result in results:
+		current[result["name"]] = true
+
+	for name in previous:
+		if not current.has(name):
+			print("%-56s not in current run" % name)
+
+	var comparisons: Array = []
+	for result in results:
+		var name: String = result["name"]
+		if not previous.has(name):
+			print("%-56s not in baseline" % name)
+			continue
+		var before: Dictionary = previous[name]
+		for metric in METRICS:
+			if not result.has(metric) and not before.has(metric):
+				continue
+			if not result.has(metric):
+				print("%-56s %s not in current run" % [name, metric])
+				continue
+			if not before.has(metric):
+				print("%-56s %s not in baseline" % [name, metric])
+				continue
+			comparisons.append(_compare_metric(name, metric, float(before[metric]), float(result[metric]), threshold_percent))
+	return comparisons
+
+
+func _compare_metric(name: String, metric: String, before: float, current: float, threshold_percent: float) -> Dictionary:
+	var higher_is_better: bool = METRICS[metric][0]
+	var slack: float = METRICS[metric][1]
+	var worse_by := before - current if higher_is_better else current - before
+	var change_percent := 0.0
+	if before != 0.0:
+		change_percent = (current - before) / absf(before) * 100.0
+	var regressed := worse_by > slack and worse_by > absf(before) * threshold_percent / 100.0
+	return {
+		"name": name,
+		"metric": metric,
+		"baseline": before,
+		"current": current,
+		"change_percent": change_percent,
+		"regressed": regressed,
+	}
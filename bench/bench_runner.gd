@@ -0,0 +1,226 @@
+extends SceneTree
+## Headless benchmark runner for the GDScript-facing cost of the Vodozemac* classes.
+##
+## Every call goes through the same path game code uses (Variant dispatch,
+## String marshalling, result Dictionary), so the numbers are what a script pays
+## per call rather than the cost of the underlying crypto alone.
+##
+## Usage (the import step registers the extension for a fresh checkout):
+##   godot --headless --path . --import
+##   godot --headless --path . --script res://bench/bench_runner.gd -- [options]
+##
+## Options:
+##   --iterations=N   timed calls per case (default 1000)
+##   --warmup=N       untimed calls per case before timing (default 50)
+##   --sizes=A,B,...  plaintext sizes in bytes for encrypt/decrypt (default 32,1024,16384)
+##   --filter=TEXT    only run cases whose name contains TEXT
+##   --output=PATH    JSON results file (default res://bench_output.txt)
+##   --baseline=PATH  compare against a previously saved results file
+##   --threshold=PCT  allowed regression per metric in percent (default 10);
+##                    compares ops_per_sec, p99_usec and retained_memory_bytes
+##   --workload=DIR   replay a dataset from workload_generator.gd instead of the
+##                    per-method cases; every pickle and message is used once
+##
+## retained_memory_bytes is the net change in OS.get_static_memory_usage() across
+## a case's timed loop: Godot-side memory the calls leave allocated. It is not
+## allocation volume, since Strings and Dictionaries freed inside the loop do not
+## count, and it does not see the Rust allocator. Static memory is only tracked
+## in debug builds, so the field is omitted elsewhere.
+##
+## Exit code is 0 on success, 1 when a case fails or the report cannot be
+## written or the baseline cannot be read, and 2 when a metric regresses
+## against the baseline.
+
+const BenchCases = preload("res://bench/bench_cases.gd")
+const BenchCompare = preload("res://bench/bench_compare.gd")
+const Workload = preload("res://bench/workload.gd")
+
+## Case whose mean latency is reported as the dispatch baseline: a const getter
+## with no native work, so its cost is the GDScript -> GDExtension round trip.
+const DISPATCH_BASELINE_CASE := "VodozemacAccount.get_last_error"
+
+const METRIC_NOTES := {
+	"retained_memory_bytes": "net OS.get_static_memory_usage() change across the timed loop; retained growth, not allocation volume; debug builds only",
+}
+
+var _iterations := 1000
+var _warmup := 50
+var _sizes := PackedInt32Array([32, 1024, 16384])
+var _filter := ""
+var _output := "res://bench_output.txt"
+var _baseline := ""
+var _threshold := 10.0
+var _workload := ""
+
+
+func _initialize() -> void:
+	_parse_args(OS.get_cmdline_user_args())
+
+	var cases: Array
+	if _workload.is_empty():
+		cases = BenchCases.new().build(_sizes)
+	else:
+		cases = Workload.new().build_cases(_workload)
+
+	var results: Array = []
+	var failed := cases.is_empty()
+	for bench_case in cases:
+		if not _filter.is_empty() and not bench_case["name"].contains(_filter):
+			continue
+		var result := _run_case(bench_case)
+		if result.has("error"):
+			failed = true
+			printerr("%-56s FAILED: %s" % [result["name"], result["error"]])
+		else:
+			print("%-56s %12.1f ops/s  mean %9.2f us  p50 %7d us  p99 %7d us" % [
+				result["name"], result["ops_per_sec"], result["mean_usec"], result["p50_usec"], result["p99_usec"]])
+		results.append(result)
+
+	var dispatch_usec := _dispatch_baseline(results)
+	for result in results:
+		if result.has("mean_usec") and dispatch_usec >= 0.0:
+			result["work_usec"] = maxf(result["mean_usec"] - dispatch_usec, 0.0)
+
+	var report := {
+		"godot_version": Engine.get_version_info()["string"],
+		"timestamp": Time.get_datetime_string_from_system(true),
+		"iterations": _iterations,
+		"workload": _workload,
+		"warmup": _warmup,
+		"dispatch_baseline_usec": dispatch_usec,
+		"metric_notes": METRIC_NOTES,
+		"results": results,
+	}
+
+	var regressed := false
+	if not _baseline.is_empty():
+		var compare := BenchCompare.new()
+		var previous := compare.load_report(_baseline)
+		if previous.is_empty():
+			failed = true
+		else:
+			var comparisons := compare.compare(previous, results, _threshold)
+			regressed = _print_regressions(comparisons)
+			report["baseline"] = _baseline
+			report["threshold_percent"] = _threshold
+			report["comparisons"] = comparisons
+
+	if not _write_report(report):
+		failed = true
+	if failed:
+		quit(1)
+	elif regressed:
+		quit(2)
+	else:
+		quit(0)
+
+
+func _parse_args(args: PackedStringArray) -> void:
+	for arg in args:
+		var value := arg.get_slice("=", 1)
+		if arg.begins_with("--iterations="):
+			_iterations = maxi(value.to_int(), 1)
+		elif arg.begins_with("--warmup="):
+			_warmup = maxi(value.to_int(), 0)
+		elif arg.begins_with("--sizes="):
+			_sizes = PackedInt32Array()
+			for size in value.split(",", false):
+				_sizes.append(size.to_int())
+		elif arg.begins_with("--filter="):
+			_filter = value
+		elif arg.begins_with("--output="):
+			_output = value
+		elif arg.begins_with("--baseline="):
+			_baseline = value
+		elif arg.begins_with("--threshold="):
+			_threshold = maxf(value.to_float(), 0.0)
+		elif arg.begins_with("--workload="):
+			_workload = value
+		else:
+			push_warning("Unknown argument: %s" % arg)
+
+
+## Cases with a fixed "calls" count consume their inputs once and run without warmup.
+func _run_case(bench_case: Dictionary) -> Dictionary:
+	var iterations: int = bench_case.get("calls", _iterations)
+	var warmup: int = 0 if bench_case.has("calls") else _warmup
+	var result := {
+		"name": bench_case["name"],
+		"class": bench_case["class"],
+		"method": bench_case["method"],
+		"payload_bytes": bench_case["payload"],
+		"calls": iterations,
+	}
+	if iterations <= 0:
+		result["error"] = "nothing to run"
+		return result
+	var invoke: Callable = bench_case["invoke"]
+	var state: Dictionary = bench_case["setup"].call(warmup + iterations)
+
+	for i in warmup:
+		if not invoke.call(state, i):
+			result["error"] = "warmup call %d failed" % i
+			return result
+
+	var samples := PackedInt64Array()
+	samples.resize(iterations)
+	var memory_before := OS.get_static_memory_usage()
+	var started := Time.get_ticks_usec()
+	for i in iterations:
+		var call_started := Time.get_ticks_usec()
+		var ok: bool = invoke.call(state, warmup + i)
+		samples[i] = Time.get_ticks_usec() - call_started
+		if not ok:
+			result["error"] = "call %d failed" % (warmup + i)
+			return result
+	var elapsed := Time.get_ticks_usec() - started
+	var retained_memory := OS.get_static_memory_usage() - memory_before
+
+	samples.sort()
+	result["ops_per_sec"] = iterations * 1000000.0 / maxi(elapsed, 1)
+	result["mean_usec"] = float(elapsed) / iterations
+	result["p50_usec"] = _percentile(samples, 50.0)
+	result["p99_usec"] = _percentile(samples, 99.0)
+	result["max_usec"] = samples[iterations - 1]
+	if OS.is_debug_build():
+		result["retained_memory_bytes"] = retained_memory
+	return result
+
+
+## Nearest-rank percentile of already sorted `samples`.
+func _percentile(samples: PackedInt64Array, percent: float) -> int:
+	var rank := ceili(percent / 100.0 * samples.size()) - 1
+	return samples[clampi(rank, 0, samples.size() - 1)]
+
+
+## Prints every regressed metric and returns whether there was any.
+func _print_regressions(comparisons: Array) -> bool:
+	var regressed := false
+	for comparison in comparisons:
+		if not comparison["regressed"]:
+			continue
+		regressed = true
+		printerr("%-56s REGRESSED %s: %.2f -> %.2f (%+.1f%%)" % [
+			comparison["name"], comparison["metric"], comparison["baseline"],
+			comparison["current"], comparison["change_percent"]])
+	if not regressed:
+		print("No regressions beyond %.1f%% against %s" % [_threshold, _baseline])
+	return regressed
+
+
+func _dispatch_baseline(results: Array) -> float:
+	for result in results:
+		if result["name"] == DISPATCH_BASELINE_CASE and result.has("mean_usec"):
+			return result["mean_usec"]
+	return -1.0
+
+
+func _write_report(report: Dictionary) -> bool:
+	var path := ProjectSettings.globalize_path(_output)
+	var file := FileAccess.open(path, FileAccess.WRITE)
+	if file == null:
+		printerr("Cannot write %s: %s" % [path, error_string(FileAccess.get_open_error())])
+		return false
+	file.store_string(JSON.stringify(report, "\t"))
+	print("Results written to %s" % path)
+	return true
@@ -0,0 +1,127 @@
+extends RefCounted
+## On-disk format of a synthetic workload and the benchmark cases that replay it.
+##
+## A workload directory contains:
+##   manifest.json  - seed, parameters, pickle key and one entry per pickled object
+##   stream.jsonl   - one encrypted message per line, in delivery order
+##   pickles/       - one vodozemac pickle per file, referenced from the manifest
+##
+## Stream records are {"kind": "olm", "session": i, "message_type": t, "ciphertext": c}
+## or {"kind": "megolm", "session": i, "ciphertext": c}, where `session` indexes
+## manifest["olm_sessions"] or manifest["megolm_sessions"] respectively and the
+## message is decrypted with that entry's inbound side.
+
+const FORMAT_VERSION := 1
+const MANIFEST_FILE := "manifest.json"
+const STREAM_FILE := "stream.jsonl"
+const PICKLE_DIR := "pickles"
+
+
+## Loads and validates the manifest in `dir`; returns an empty Dictionary on failure.
+func load_manifest(dir: String) -> Dictionary:
+	var path := dir.path_join(MANIFEST_FILE)
+	var manifest = JSON.parse_string(FileAccess.get_file_as_string(path))
+	if not (manifest is Dictionary) or int(manifest.get("format_version", 0)) != FORMAT_VERSION:
+		printerr("%s is not a version %d workload manifest" % [path, FORMAT_VERSION])
+		return {}
+	return manifest
+
+
+func load_stream(dir: String) -> Array:
+	var records: Array = []
+	var file := FileAccess.open(dir.path_join(STREAM_FILE), FileAccess.READ)
+	if file == null:
+		printerr("Cannot read %s: %s" % [dir.path_join(STREAM_FILE), error_string(FileAccess.get_open_error())])
+		return records
+	while not file.eof_reached():
+		var line := file.get_line()
+		if not line.is_empty():
+			records.append(JSON.parse_string(line))
+	return records
+
+
+## Every pickle in the workload as {"class": ..., "pickle": ...}.
+func pickled_objects(dir: String, manifest: Dictionary) -> Array:
+	var objects: Array = []
+	for account in manifest["accounts"]:
+		objects.append(_pickled(dir, "VodozemacAccount", account["file"]))
+	for session in manifest["olm_sessions"]:
+		objects.append(_pickled(dir, "VodozemacSession", session["outbound_file"]))
+		objects.append(_pickled(dir, "VodozemacSession", session["inbound_file"]))
+	for session in manifest["megolm_sessions"]:
+		objects.append(_pickled(dir, "VodozemacGroupSession", session["outbound_file"]))
+		objects.append(_pickled(dir, "VodozemacInboundGroupSession", session["inbound_file"]))
+	return objects
+
+
+## Replay cases in the shape built by bench_cases.gd, with a fixed "calls" count
+## because every pickle and every message is used exactly once.
+func build_cases(dir: String) -> Array:
+	var manifest := load_manifest(dir)
+	if manifest.is_empty():
+		return []
+	var key := PackedByteArray(manifest["pickle_key"].hex_decode())
+	var objects := pickled_objects(dir, manifest)
+	var stream := load_stream(dir)
+	return [
+		{
+			"name": "Workload.from_pickle",
+			"class": "Workload",
+			"method": "from_pickle",
+			"payload": -1,
+			"calls": objects.size(),
+			"setup": _with_objects.bind(objects, key),
+			"invoke": _restore,
+		},
+		{
+			"name": "Workload.replay",
+			"class": "Workload",
+			"method": "decrypt",
+			"payload": -1,
+			"calls": stream.size(),
+			"setup": _with_receivers.bind(dir, manifest, key, stream),
+			"invoke": _replay,
+		},
+	]
+
+
+func _pickled(dir: String, cls: String, file: String) -> Dictionary:
+	return {"class": cls, "pickle": _read_pickle(dir, file)}
+
+
+func _read_pickle(dir: String, file: String) -> String:
+	return FileAccess.get_file_as_string(dir.path_join(PICKLE_DIR).path_join(file))
+
+
+func _unpickle(cls: String, pickle: String, key: PackedByteArray) -> Object:
+	var object = ClassDB.instantiate(cls)
+	if object.from_pickle(pickle, key) != OK:
+		push_error("%s.from_pickle failed: %s" % [cls, object.get_last_error()])
+	return object
+
+
+func _with_receivers(_calls: int, dir: String, manifest: Dictionary, key: PackedByteArray, stream: Array) -> Dictionary:
+	var olm: Array = []
+	for session in manifest["olm_sessions"]:
+		olm.append(_unpickle("VodozemacSession", _read_pickle(dir, session["inbound_file"]), key))
+	var megolm: Array = []
+	for session in manifest["megolm_sessions"]:
+		megolm.append(_unpickle("VodozemacInboundGroupSession", _read_pickle(dir, session["inbound_file"]), key))
+	return {"olm": olm, "megolm": megolm, "stream": stream}
+
+
+func _with_objects(_calls: int, objects: Array, key: PackedByteArray) -> Dictionary:
+	return {"objects": objects, "key": key}
+
+
+func _restore(s: Dictionary, i: int) -> bool:
+	var object: Dictionary = s["objects"][i]
+	return ClassDB.instantiate(object["class"]).from_pickle(object["pickle"], s["key"]) == OK
+
+
+func _replay(s: Dictionary, i: int) -> bool:
+	var record: Dictionary = s["stream"][i]
+	var session := int(record["session"])
+	if record["kind"] == "olm":
+		return s["olm"][session].decrypt(int(record["message_type"]), record["ciphertext"]).get("success", false)
+	return s["megolm"][session].decrypt(record["ciphertext"]).get("success", false)
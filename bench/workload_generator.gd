@@ -0,0 +1,303 @@
+extends SceneTree
+## Generates a synthetic crypto workload for reproducible benchmarks.
+##
+## The seed fixes the shape of the dataset: which accounts talk to each other,
+## how far every megolm ratchet has advanced, which receivers joined late, how
+## many Olm message keys were skipped, payload sizes, plaintexts and delivery
+## order. Key material and ciphertexts still come from the library's system RNG,
+## so two runs with the same seed produce datasets of the same size and structure
+## but not byte-identical pickles.
+##
+## Usage:
+##   godot --headless --path . --script res://bench/workload_generator.gd -- [options]
+##   godot --headless --path . --script res://bench/bench_runner.gd -- --workload=res://bench_workload
+##
+## Options:
+##   --seed=N                  structure seed (default 1)
+##   --accounts=N              Olm accounts, at least 2 (default 8)
+##   --rooms=N                 rooms the megolm sessions are spread over (default 4)
+##   --megolm-sessions=N       outbound/inbound megolm session pairs (default 16)
+##   --olm-sessions=N          Olm session pairs between random accounts (default 8)
+##   --mean-message-index=N    mean ratchet position of a megolm session (default 40)
+##   --max-skipped=N           most undelivered messages per Olm session (default 20,
+##                             at most 40: vodozemac keeps 40 skipped message keys
+##                             per receiver chain, so older ones could not be replayed)
+##   --late-join-percent=N     inbound megolm sessions created mid-ratchet (default 25)
+##   --stream-messages=N       megolm messages in the replay stream (default 500)
+##   --output=DIR              dataset directory (default res://bench_workload)
+
+const BenchCases = preload("res://bench/bench_cases.gd")
+const Workload = preload("res://bench/workload.gd")
+
+## Log-normal payload sizes: median of about 150 bytes, clamped to chat-message range.
+const PAYLOAD_LOG_MEAN := 5.0
+const PAYLOAD_LOG_DEVIATION := 1.0
+const MIN_PAYLOAD := 16
+const MAX_PAYLOAD := 65536
+const MAX_MESSAGE_INDEX := 5000
+## Skipped message keys vodozemac keeps per Olm receiver chain.
+const MAX_SKIPPED_MESSAGE_KEYS := 40
+const PLAINTEXT_ALPHABET := "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 "
+
+var _params := {
+	"seed": 1,
+	"accounts": 8,
+	"rooms": 4,
+	"megolm_sessions": 16,
+	"olm_sessions": 8,
+	"mean_message_index": 40,
+	"max_skipped": 20,
+	"late_join_percent": 25,
+	"stream_messages": 500,
+}
+var _output := "res://bench_workload"
+
+var _rng := RandomNumberGenerator.new()
+var _cases := BenchCases.new()
+var _key := PackedByteArray()
+var _dir := ""
+
+
+func _initialize() -> void:
+	if not _parse_args(OS.get_cmdline_user_args()):
+		quit(1)
+		return
+	_rng.seed = _params["seed"]
+	_key = _cases.pickle_key()
+	_dir = ProjectSettings.globalize_path(_output)
+	if DirAccess.make_dir_recursive_absolute(_dir.path_join(Workload.PICKLE_DIR)) != OK:
+		printerr("Cannot create %s" % _dir)
+		quit(1)
+		return
+
+	var stream: Array = []
+	var accounts := _generate_accounts()
+	var olm_sessions: Array = []
+	var megolm_sessions: Array = []
+	if not _generate_olm_sessions(accounts, stream, olm_sessions) \
+			or not _generate_megolm_sessions(accounts, stream, megolm_sessions):
+		quit(1)
+		return
+	_shuffle(stream)
+
+	var account_entries: Array = []
+	var ok := _save_accounts(accounts, account_entries)
+	ok = _save_sessions("olm", olm_sessions) and ok
+	ok = _save_sessions("megolm", megolm_sessions) and ok
+	var manifest := {
+		"format_version": Workload.FORMAT_VERSION,
+		"params": _params,
+		"pickle_key": _key.hex_encode(),
+		"accounts": account_entries,
+		"olm_sessions": olm_sessions,
+		"megolm_sessions": megolm_sessions,
+	}
+	ok = _write(Workload.MANIFEST_FILE, JSON.stringify(manifest, "\t")) and ok
+	var lines := PackedStringArray()
+	for record in stream:
+		lines.append(JSON.stringify(record))
+	ok = _write(Workload.STREAM_FILE, "\n".join(lines) + "\n") and ok
+
+	print("Wrote %d accounts, %d Olm and %d megolm session pairs, %d messages to %s" % [
+		accounts.size(), olm_sessions.size(), megolm_sessions.size(), stream.size(), _dir])
+	quit(0 if ok else 1)
+
+
+func _parse_args(args: PackedStringArray) -> bool:
+	for arg in args:
+		var name := arg.get_slice("=", 0).trim_prefix("--").replace("-", "_")
+		var value := arg.get_slice("=", 1)
+		if name == "output":
+			_output = value
+		elif not _params.has(name):
+			push_warning("Unknown argument: %s" % arg)
+		elif not value.is_valid_int():
+			printerr("Invalid value for --%s: %s" % [name.replace("_", "-"), value])
+			return false
+		else:
+			_params[name] = maxi(value.to_int(), 0)
+	if _params["accounts"] < 2:
+		printerr("--accounts must be at least 2")
+		return false
+	if _params["rooms"] < 1:
+		printerr("--rooms must be at least 1")
+		return false
+	if _params["max_skipped"] > MAX_SKIPPED_MESSAGE_KEYS:
+		printerr("--max-skipped must be at most %d" % MAX_SKIPPED_MESSAGE_KEYS)
+		return false
+	return true
+
+
+func _generate_accounts() -> Array:
+	var accounts: Array = []
+	for i in _params["accounts"]:
+		var account := _cases.new_account()
+		account.generate_one_time_keys(_rng.randi_range(1, account.get_max_number_of_one_time_keys()))
+		account.mark_keys_as_published()
+		accounts.append(account)
+	return accounts
+
+
+## Each pair leaves up to --max-skipped messages undelivered, so the receiving
+## session carries skipped message keys; those messages go to the replay stream.
+## Fills `sessions` and returns false after printing the error if a step fails.
+func _generate_olm_sessions(accounts: Array, stream: Array, sessions: Array) -> bool:
+	for i in _params["olm_sessions"]:
+		var sender_index := _rng.randi_range(0, accounts.size() - 1)
+		var receiver_index := (sender_index + _rng.randi_range(1, accounts.size() - 1)) % accounts.size()
+		var sender: VodozemacAccount = accounts[sender_index]
+		var receiver: VodozemacAccount = accounts[receiver_index]
+
+		receiver.generate_one_time_keys(1)
+		var otk: String = _cases.one_time_keys(receiver)[0]
+		receiver.mark_keys_as_published()
+
+		var outbound: VodozemacSession = sender.create_outbound_session(_cases.identity_key(receiver), otk)
+		if outbound == null:
+			printerr("Olm session %d: create_outbound_session failed: %s" % [i, sender.get_last_error()])
+			return false
+		var first: Dictionary = outbound.encrypt(_plaintext())
+		var accepted: Dictionary = receiver.create_inbound_session(_cases.identity_key(sender), first["message_type"], first["ciphertext"])
+		if not accepted.get("success", false):
+			printerr("Olm session %d: create_inbound_session failed: %s" % [i, accepted.get("error", "")])
+			return false
+		var inbound: VodozemacSession = accepted["session"]
+
+		var skipped := _rng.randi_range(0, _params["max_skipped"])
+		for k in skipped:
+			var message: Dictionary = outbound.encrypt(_plaintext())
+			stream.append({
+				"kind": "olm",
+				"session": i,
+				"message_type": message["message_type"],
+				"ciphertext": message["ciphertext"],
+			})
+		var latest: Dictionary = outbound.encrypt(_plaintext())
+		var decrypted: Dictionary = inbound.decrypt(latest["message_type"], latest["ciphertext"])
+		if not decrypted.get("success", false):
+			printerr("Olm session %d: decrypt failed: %s" % [i, decrypted.get("error", "")])
+			return false
+
+		sessions.append({
+			"sender": sender_index,
+			"receiver": receiver_index,
+			"session_id": outbound.get_session_id(),
+			"skipped": skipped,
+			"outbound": outbound,
+			"inbound": inbound,
+		})
+	return true
+
+
+## Ratchet positions are exponentially distributed around --mean-message-index;
+## late joiners only know the session from its position at join time onwards.
+## Fills `sessions` and returns false after printing the error if a step fails.
+func _generate_megolm_sessions(accounts: Array, stream: Array, sessions: Array) -> bool:
+	for i in _params["megolm_sessions"]:
+		var group := VodozemacGroupSession.new()
+		if group.initialize() != OK:
+			printerr("Megolm session %d: initialize failed: %s" % [i, group.get_last_error()])
+			return false
+		var late_join: bool = _rng.randi_range(1, 100) <= _params["late_join_percent"]
+		var inbound := VodozemacInboundGroupSession.new()
+		var session_key := ""
+		if not late_join:
+			session_key = group.get_session_key()
+
+		var advance := mini(int(-log(1.0 - _rng.randf()) * _params["mean_message_index"]), MAX_MESSAGE_INDEX)
+		for k in advance:
+			group.encrypt(_plaintext())
+		if late_join:
+			session_key = group.get_session_key()
+		if inbound.initialize_from_session_key(session_key) != OK:
+			printerr("Megolm session %d: initialize_from_session_key failed: %s" % [i, inbound.get_last_error()])
+			return false
+
+		sessions.append({
+			"room": i % _params["rooms"],
+			"sender": _rng.randi_range(0, accounts.size() - 1),
+			"session_id": group.get_session_id(),
+			"late_join": late_join,
+			"first_known_index": inbound.get_first_known_index(),
+			"outbound": group,
+			"inbound": inbound,
+		})
+
+	if sessions.is_empty():
+		return true
+	for k in _params["stream_messages"]:
+		var index := _rng.randi_range(0, sessions.size() - 1)
+		var encrypted: Dictionary = sessions[index]["outbound"].encrypt(_plaintext())
+		if not encrypted.get("success", false):
+			printerr("Megolm session %d: encrypt failed: %s" % [index, encrypted.get("error", "")])
+			return false
+		stream.append({
+			"kind": "megolm",
+			"session": index,
+			"ciphertext": encrypted["ciphertext"],
+		})
+	for session in sessions:
+		session["message_index"] = session["outbound"].get_message_index()
+	return true
+
+
+## Fisher-Yates driven by the seeded generator; Array.shuffle() uses the global RNG.
+func _shuffle(items: Array) -> void:
+	for i in range(items.size() - 1, 0, -1):
+		var j := _rng.randi_range(0, i)
+		var item = items[i]
+		items[i] = items[j]
+		items[j] = item
+
+
+func _plaintext() -> String:
+	var size := clampi(int(exp(_rng.randfn(PAYLOAD_LOG_MEAN, PAYLOAD_LOG_DEVIATION))), MIN_PAYLOAD, MAX_PAYLOAD)
+	var chars := PackedStringArray()
+	chars.resize(size)
+	for i in size:
+		chars[i] = PLAINTEXT_ALPHABET[_rng.randi_range(0, PLAINTEXT_ALPHABET.length() - 1)]
+	return "".join(chars)
+
+
+## Appends one manifest entry per account to `entries`. Returns false if any
+## pickle could not be taken or written.
+func _save_accounts(accounts: Array, entries: Array) -> bool:
+	var ok := true
+	for i in accounts.size():
+		var account: VodozemacAccount = accounts[i]
+		var file := "account_%04d.pickle" % i
+		ok = _write_pickle(file, account.pickle(_key), account.get_last_error()) and ok
+		entries.append({"file": file, "curve25519": _cases.identity_key(account)})
+	return ok
+
+
+## Replaces the live "outbound"/"inbound" objects of each entry with the names of
+## their pickle files. Returns false if any pickle could not be taken or written.
+func _save_sessions(kind: String, sessions: Array) -> bool:
+	var ok := true
+	for i in sessions.size():
+		var entry: Dictionary = sessions[i]
+		for side in ["outbound", "inbound"]:
+			var file := "%s_%04d_%s.pickle" % [kind, i, side]
+			ok = _write_pickle(file, entry[side].pickle(_key), entry[side].get_last_error()) and ok
+			entry.erase(side)
+			entry[side + "_file"] = file
+	return ok
+
+
+## `error` is the object's last error, reported when `pickle` is empty.
+func _write_pickle(file: String, pickle: String, error: String) -> bool:
+	if pickle.is_empty():
+		printerr("Cannot pickle %s: %s" % [file, error])
+		return false
+	return _write(Workload.PICKLE_DIR.path_join(file), pickle)
+
+
+func _write(relative_path: String, contents: String) -> bool:
+	var path := _dir.path_join(relative_path)
+	var file := FileAccess.open(path, FileAccess.WRITE)
+	if file == null:
+		printerr("Cannot write %s: %s" % [path, error_string(FileAccess.get_open_error())])
+		return false
+	file.store_string(contents)
+	return true
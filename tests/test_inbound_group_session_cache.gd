@@ -0,0 +1,168 @@
+extends SceneTree
+## Headless checks for VodozemacInboundGroupSessionCache.
+##
+## Usage (the import step registers the extension for a fresh checkout):
+##   godot --headless --path . --import
+##   godot --headless --path . --script res://tests/test_inbound_group_session_cache.gd
+##
+## Exit code is 0 when every check passes and 1 otherwise.
+
+const Cache = preload("res://addons/godot-vodozemac/vodozemac_inbound_group_session_cache.gd")
+
+const ROOM := "!room:example.org"
+const PLAINTEXT := "hello"
+const STORAGE_DIR := "user://test_inbound_group_session_cache"
+
+var _failures := 0
+
+
+func _initialize() -> void:
+	_test_eviction_order()
+	_test_unpickles_on_first_use()
+	_test_lowering_max_resident()
+	_test_storage_dir_round_trip()
+	_test_rejects_bad_pickle_key()
+
+	if _failures > 0:
+		printerr("%d check(s) failed" % _failures)
+		quit(1)
+	else:
+		print("All checks passed")
+		quit(0)
+
+
+func _test_eviction_order() -> void:
+	var cache := Cache.new(_pickle_key(), 2)
+	var s1 := _megolm_session()
+	var s2 := _megolm_session()
+	var s3 := _megolm_session()
+	var s4 := _megolm_session()
+	for s in [s1, s2, s3]:
+		_check(cache.add_session(ROOM, s["inbound"]) == OK, "eviction: add_session")
+	_check(not cache.is_resident(ROOM, s1["id"]), "eviction: oldest session is evicted first")
+	_check(cache.is_resident(ROOM, s2["id"]) and cache.is_resident(ROOM, s3["id"]), "eviction: newer sessions stay resident")
+
+	# Using s2 makes s3 the least recently used.
+	_check(cache.get_session(ROOM, s2["id"]) != null, "eviction: get_session of a resident session")
+	_check(cache.add_session(ROOM, s4["inbound"]) == OK, "eviction: add_session")
+	_check(not cache.is_resident(ROOM, s3["id"]), "eviction: least recently used session is evicted")
+	_check(cache.is_resident(ROOM, s2["id"]), "eviction: recently used session stays resident")
+	_check(cache.get_resident_count() == 2 and cache.get_session_count() == 4, "eviction: counts")
+
+	# Bringing s1 back evicts s2, now the least recently used.
+	var result := cache.decrypt(ROOM, s1["id"], s1["ciphertext"])
+	_check(result.get("plaintext", "") == PLAINTEXT, "eviction: decrypt of an evicted session")
+	_check(not cache.is_resident(ROOM, s2["id"]), "eviction: decrypt evicts the least recently used session")
+
+
+func _test_unpickles_on_first_use() -> void:
+	var cache := Cache.new(_pickle_key(), 4)
+	var s1 := _megolm_session()
+	var s2 := _megolm_session()
+	for s in [s1, s2]:
+		_check(cache.add_pickle(ROOM, s["id"], s["pickle"]) == OK, "lazy: add_pickle")
+	_check(cache.get_resident_count() == 0 and cache.get_session_count() == 2, "lazy: add_pickle does not unpickle")
+
+	var session := cache.get_session(ROOM, s1["id"])
+	_check(session != null and session.get_session_id() == s1["id"], "lazy: get_session unpickles")
+	_check(cache.is_resident(ROOM, s1["id"]) and not cache.is_resident(ROOM, s2["id"]), "lazy: only the used session is unpickled")
+
+	var result := cache.decrypt(ROOM, s2["id"], s2["ciphertext"])
+	_check(result.get("plaintext", "") == PLAINTEXT, "lazy: decrypt unpickles")
+	_check(cache.get_resident_count() == 2, "lazy: both sessions resident after use")
+
+	_check(cache.add_pickle(ROOM, "missing", "") == ERR_INVALID_PARAMETER, "lazy: empty pickle is rejected")
+	_check(cache.get_session(ROOM, "missing") == null and not cache.get_last_error().is_empty(), "lazy: unknown session sets the last error")
+
+
+func _test_lowering_max_resident() -> void:
+	var cache := Cache.new(_pickle_key(), 4)
+	var sessions := [_megolm_session(), _megolm_session(), _megolm_session()]
+	for s in sessions:
+		_check(cache.add_session(ROOM, s["inbound"]) == OK, "max_resident: add_session")
+	var first_id: String = sessions[0]["id"]
+	_check(cache.get_session(ROOM, first_id) != null, "max_resident: get_session")
+
+	cache.max_resident = 1
+	_check(cache.get_resident_count() == 1, "max_resident: lowering the limit evicts immediately")
+	_check(cache.is_resident(ROOM, first_id), "max_resident: most recently used session stays resident")
+	_check(cache.get_session_count() == 3, "max_resident: evicted sessions stay cached")
+	for s in sessions:
+		_check(not cache.get_pickle(ROOM, s["id"]).is_empty(), "max_resident: get_pickle after eviction")
+
+
+func _test_storage_dir_round_trip() -> void:
+	_clear_storage_dir()
+	var cache := Cache.new(_pickle_key(), 1, STORAGE_DIR)
+	var s1 := _megolm_session()
+	var s2 := _megolm_session()
+	var s3 := _megolm_session()
+	for s in [s1, s2, s3]:
+		_check(cache.add_session(ROOM, s["inbound"]) == OK, "storage: add_session")
+	_check(cache.flush() == OK, "storage: flush")
+	cache.remove_session(ROOM, s1["id"])
+	_check(not cache.has_session(ROOM, s1["id"]), "storage: remove_session")
+
+	var reopened := Cache.new(_pickle_key(), 1, STORAGE_DIR)
+	_check(reopened.add_stored(ROOM, s1["id"]) == ERR_FILE_NOT_FOUND, "storage: removed session has no file")
+	_check(reopened.add_stored(ROOM, s2["id"]) == OK, "storage: add_stored of a spilled session")
+	_check(reopened.add_stored(ROOM, s3["id"]) == OK, "storage: add_stored of a flushed session")
+	_check(reopened.get_resident_count() == 0, "storage: add_stored does not unpickle")
+	for s in [s2, s3]:
+		var result := reopened.decrypt(ROOM, s["id"], s["ciphertext"])
+		_check(result.get("plaintext", "") == PLAINTEXT, "storage: decrypt after reopening")
+
+	var empty := _megolm_session()
+	var file := FileAccess.open(reopened._file_path(reopened._cache_key(ROOM, empty["id"])), FileAccess.WRITE)
+	file.close()
+	_check(reopened.add_stored(ROOM, empty["id"]) == OK, "storage: add_stored of an empty file")
+	_check(reopened.get_session(ROOM, empty["id"]) == null, "storage: empty pickle file fails to load")
+	_check(reopened.get_last_error().contains("empty"), "storage: empty pickle file sets the last error")
+
+	_check(Cache.new(_pickle_key()).flush() == ERR_UNCONFIGURED, "storage: flush needs a storage_dir")
+	_clear_storage_dir()
+
+
+func _test_rejects_bad_pickle_key() -> void:
+	var cache := Cache.new(PackedByteArray([1, 2, 3]))
+	var s := _megolm_session()
+	_check(cache.add_session(ROOM, s["inbound"]) == ERR_INVALID_PARAMETER, "pickle key: add_session fails with a short key")
+	_check(cache.add_pickle(ROOM, s["id"], s["pickle"]) == ERR_INVALID_PARAMETER, "pickle key: add_pickle fails with a short key")
+	_check(cache.get_last_error().contains("32 bytes"), "pickle key: last error names the expected size")
+
+
+func _pickle_key() -> PackedByteArray:
+	var key := PackedByteArray()
+	key.resize(Cache.PICKLE_KEY_SIZE)
+	for i in key.size():
+		key[i] = i
+	return key
+
+
+## Outbound/inbound pair with one message encrypted at index 0 and the inbound
+## pickle taken before that message is decrypted.
+func _megolm_session() -> Dictionary:
+	var group := VodozemacGroupSession.new()
+	_check(group.initialize() == OK, "setup: VodozemacGroupSession.initialize")
+	var inbound := VodozemacInboundGroupSession.new()
+	_check(inbound.initialize_from_session_key(group.get_session_key()) == OK, "setup: initialize_from_session_key")
+	var encrypted := group.encrypt(PLAINTEXT)
+	_check(encrypted.get("success", false), "setup: VodozemacGroupSession.encrypt")
+	return {
+		"inbound": inbound,
+		"id": inbound.get_session_id(),
+		"ciphertext": encrypted.get("ciphertext", ""),
+		"pickle": inbound.pickle(_pickle_key()),
+	}
+
+
+func _clear_storage_dir() -> void:
+	var path := ProjectSettings.globalize_path(STORAGE_DIR)
+	for file_name in DirAccess.get_files_at(path):
+		DirAccess.remove_absolute(path.path_join(file_name))
+
+
+func _check(condition: bool, description: String) -> void:
+	if not condition:
+		_failures += 1
+		printerr("FAILED: " + description)